@@ -3,7 +3,7 @@
  *
  * @brief   Memory allocation / free operations.
  ***********************************************************************/
-#include "netpbm.h"
+#include "netPBM.h"
 
  /** *********************************************************************
   * @author Tristan Opbroek
@@ -104,8 +104,64 @@ void createBoolArray(bool**& ptr, int cols, int rows)
  ***********************************************************************/
 void cleanUp(bool** arr1, image picture)
 {
+	for (int i = 0; i < picture.rows; i++)
+		delete[] arr1[i];
 	delete [] arr1;
+	cleanUpImage(picture);
+}
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Frees the pixel arrays of an image.
+ *
+ * @param [in] picture - Image, and accompanying arrays.
+ * @par Example:
+   @verbatim
+ * image picture;
+ * createArray(picture.redgray, picture.cols, picture.rows);
+ * createArray(picture.green, picture.cols, picture.rows);
+ * createArray(picture.blue, picture.cols, picture.rows);
+ * cleanUpImage(picture); //Frees up memory
+   @endverbatim
+ ***********************************************************************/
+void cleanUpImage(image picture)
+{
+	for (int i = 0; i < picture.rows; i++)
+	{
+		delete[] picture.blue[i];
+		delete[] picture.redgray[i];
+		delete[] picture.green[i];
+	}
 	delete [] picture.blue;
 	delete [] picture.redgray;
 	delete[] picture.green;
-}
\ No newline at end of file
+}
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Frees the arrays held by a tile index.
+ *
+ * @param[in, out] tiles - Tile index built by buildTileIndex.
+ * @par Example:
+   @verbatim
+ * tileIndex tiles;
+ * buildTileIndex(picture, tiles, TILE_SIZE);
+ * cleanUpTiles(tiles); //Frees up memory
+   @endverbatim
+ ***********************************************************************/
+void cleanUpTiles(tileIndex& tiles)
+{
+	for (int i = 0; i < tiles.tileRows; i++)
+	{
+		delete[] tiles.uniform[i];
+		delete[] tiles.redgray[i];
+		delete[] tiles.green[i];
+		delete[] tiles.blue[i];
+	}
+	delete[] tiles.uniform;
+	delete[] tiles.redgray;
+	delete[] tiles.green;
+	delete[] tiles.blue;
+}
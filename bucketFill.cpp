@@ -0,0 +1,101 @@
+/** *********************************************************************
+ * @file
+ *
+ * @brief   Recursive bucket fill. This is the reference fill that every
+ * faster fill must match.
+ ***********************************************************************/
+#include "netPBM.h"
+
+ /** *********************************************************************
+  * @author Tristan Opbroek
+  *
+  * @par Description:
+  * Compares two color structures and determines if they are equal.
+  *
+  *
+  * @param[in] color1 - The first color in the comparison
+  * @param[in] color2 - The second color in the comparison
+  *
+  * @returns true - Colors are equal
+  * @returns false - Colors are not equal
+  *
+ * @par Example:
+   @verbatim
+    color c1;
+    color c2;
+    c1.redValue = 1
+    c1.greenValue = 1
+    c1.blueValue = 1
+    
+    c2.redValue = 1
+    c2.greenValue = 1
+    c2.blueValue = 1
+    
+    cout << isEqual(c1, c2) << endl; //Outputs true.
+   @endverbatim
+  ***********************************************************************/
+bool isEqual(color color1, color color2)
+{
+    if (color1.redValue == color2.redValue &&
+        color1.greenValue == color2.greenValue &&
+        color1.blueValue == color2.blueValue)
+        return true;
+    else
+        return false;
+}
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Recursively steps through an image and replaces the color of all pixels of the same color that are touching, within bounds of the image.
+ * 
+ *
+ *
+ * @param[in] picture - The image struct being passed in
+ * @param[in] newColor - The color to replace pixels with.
+ * @param[in] ogColor - The original pixel color (target pixel)
+ * @param[in] row - Target pixel row
+ * @param[in] col - Target pixel col
+ * @param[in] adjPixels - 2D array of used pixels.
+ * 
+ * 
+ *
+* @par Example:
+  @verbatim
+  image picture; //Contains good image data
+  color newColor; //Contains 255, 0, 0; or the color red
+  color ogCOlor; //Contains color of pixel at row, col, in image
+  int row = 0; //Start bucket fill in top left corner
+  int col = 0;
+  bool** adjPixels; //2D array of size picture.row * picture.col, containing all false.
+
+   cout << isEqual(c1, c2) << endl; //Outputs true.
+  @endverbatim
+ ***********************************************************************/
+void bucketFill(image& picture, color newColor, color ogColor, int row, int col, bool**& adjPixels)
+{
+
+    color currColor;
+
+    currColor.redValue = picture.redgray[row][col];
+    currColor.greenValue = picture.green[row][col];
+    currColor.blueValue = picture.blue[row][col];
+    if (adjPixels[row][col] == false &&
+        isEqual(currColor, ogColor))
+    {
+        adjPixels[row][col] = true;
+        picture.redgray[row][col] = newColor.redValue;
+        picture.green[row][col] = newColor.greenValue;
+        picture.blue[row][col] = newColor.blueValue;
+
+        if (row != 0)
+            bucketFill(picture, newColor, ogColor, row - 1, col, adjPixels);
+        if (row != picture.rows - 1)
+            bucketFill(picture, newColor, ogColor, row + 1, col, adjPixels);
+        if (col != 0)
+            bucketFill(picture, newColor, ogColor, row, col - 1, adjPixels);
+        if (col != picture.cols - 1)
+            bucketFill(picture, newColor, ogColor, row, col + 1, adjPixels);
+    }
+    adjPixels[row][col] = true;
+}
@@ -0,0 +1,65 @@
+/** *********************************************************************
+ * @file
+ *
+ * @brief   libFuzzer entry point for the header and pixel readers.
+ *
+ * @par Building:
+ *  @verbatim
+ *  clang++ -g -O1 -fsanitize=fuzzer,address,undefined fuzzReader.cpp
+ *      imageFileIO.cpp Memory.cpp -o fuzzReader
+ *  ./fuzzReader corpusDir
+ *  @endverbatim
+ * With MSVC, add /fsanitize=fuzzer to the same three files. The test
+ * project also links this file and feeds it damaged images, so it is
+ * exercised even without a fuzzing toolchain.
+ ***********************************************************************/
+#include <cstdint>
+#include <sstream>
+#include "netPBM.h"
+
+const long long FUZZ_MAX_PIXELS = 1 << 16; /** Largest image the fuzzer will allocate*/
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Treats data as the contents of a .ppm file and runs it through
+ * readHeader and getPixelsP3/P6, the same way main reads an image.
+ * Images larger than FUZZ_MAX_PIXELS are skipped after the header so the
+ * fuzzer spends its time on parsing rather than allocation.
+ *
+ *
+ * @param[in] data - Bytes of the candidate image file.
+ * @param[in] size - Number of bytes in data.
+ *
+ * @returns 0 -- libFuzzer requires it
+ *
+ * @par Example:
+   @verbatim
+   string file = "P6\n1 1\n255\n\x01\x02\x03";
+   LLVMFuzzerTestOneInput((const uint8_t*)file.data(), file.size());
+   @endverbatim
+ ***********************************************************************/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	istringstream fin(string((const char*)data, size), ios::in | ios::binary);
+	image picture;
+
+	if (!readHeader(picture, fin))
+		return 0;
+	if (picture.magicNumber != "P3" && picture.magicNumber != "P6")
+		return 0;
+	if ((long long)picture.rows * picture.cols > FUZZ_MAX_PIXELS)
+		return 0;
+
+	createArray(picture.redgray, picture.cols, picture.rows);
+	createArray(picture.green, picture.cols, picture.rows);
+	createArray(picture.blue, picture.cols, picture.rows);
+	if (picture.magicNumber == "P3")
+		getPixelsP3(picture, fin);
+	else
+		getPixelsP6(picture, fin);
+	cleanUpImage(picture);
+
+	return 0;
+}
@@ -4,8 +4,22 @@
  * @brief   Image input output functions
  ***********************************************************************/
 #pragma once
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
 #include "netPBM.h"
 
+const size_t OUTPUT_CHUNK = 1 << 20; /** Bytes of pixel data collected per write call*/
+
  /** *********************************************************************
   * @author Tristan Opbroek
   *
@@ -43,6 +57,9 @@ void openInput(ifstream& fin, string file)
  * @param[in, out] fout - ofstream that data from file will pass through
  * @param[in] file - File that fout references.
  * @param[in] type - type of method to output file, either --ascii or --binary
+ *
+ * @returns true - The file is open
+ * @returns false - The type is invalid or the file could not be opened
 
  * @par Example:
  *  @verbatim
@@ -51,7 +68,7 @@ void openInput(ifstream& fin, string file)
  *
  * @endverbatim
  ***********************************************************************/
-void openOutput(ofstream& fout, string file, string type)
+bool openOutput(ofstream& fout, string file, string type)
 {
 	if (type == "P6")
 	{
@@ -85,10 +102,61 @@ void openOutput(ofstream& fout, string file, string type)
 	if (!fout.is_open())
 	{
 		cout << "Unable to open file: " << file << endl;
-		exit(0);
+		return false;
 	}
+	return true;
 }
 
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description: This function reads the header of a .ppm file: the
+ * magic number, any comment lines, the columns and rows, and the max value
+ * line. It leaves fin at the first byte of pixel data.
+ *
+ *
+ * @param[out] picture - struct that receives the magic number, comments,
+ * rows and cols
+ * @param[in, out] fin - stream that data from image comes from.
+ *
+ * @returns true - The header was read and the dimensions are positive
+ * @returns false - The dimensions are missing, not numbers, or not positive
+ *
+ * @par Example:
+ *  @verbatim
+ * image picture;
+ * ifstream fin = *some image file*
+ * if (readHeader(picture, fin)) //picture.rows and picture.cols are now set
+ *     getPixelsP6(picture, fin);
+ * @endverbatim
+ ***********************************************************************/
+bool readHeader(image& picture, istream& fin)
+{
+	string tempString;
+
+	fin >> picture.magicNumber;
+	fin.ignore(1000, '\n');
+	picture.comment = "";
+	while (fin.peek() == 35) //Extract Comments
+	{
+		getline(fin, tempString);
+		picture.comment += tempString + '\n';
+	}
+	try
+	{
+		getline(fin, tempString, ' '); //Get cols
+		picture.cols = stoi(tempString);
+		getline(fin, tempString, '\n'); //Get rows
+		picture.rows = stoi(tempString);
+	}
+	catch (const exception&) //stoi throws on anything that isn't a number
+	{
+		return false;
+	}
+	getline(fin, tempString, '\n'); //Skip Newline
+
+	return picture.rows > 0 && picture.cols > 0;
+}
 
 /** *********************************************************************
  * @author Tristan Opbroek
@@ -98,7 +166,7 @@ void openOutput(ofstream& fout, string file, string type)
  *
  *
  * @param[in, out] picture - struct containing picture data
- * @param[in, out] fin - ifstream that data from image comes from.
+ * @param[in, out] fin - stream that data from image comes from.
 
  * @par Example:
  *  @verbatim
@@ -107,9 +175,9 @@ void openOutput(ofstream& fout, string file, string type)
  * getPixelsP6(picture, fin); //Loads picture struct with data from fin.
  * @endverbatim
  ***********************************************************************/
-void getPixelsP6(image& picture, ifstream& fin)
+void getPixelsP6(image& picture, istream& fin)
 {
-	pixel temp;
+	pixel temp = 0;
 	for (int i = 0; i < picture.rows; i++)
 	{
 		for (int j = 0; j < picture.cols; j++)
@@ -133,7 +201,7 @@ void getPixelsP6(image& picture, ifstream& fin)
  *
  *
  * @param[in, out] picture - struct containing picture data
- * @param[in, out] fin - ifstream that data from image comes from.
+ * @param[in, out] fin - stream that data from image comes from.
  * @par Example:
  *  @verbatim
  * image picture = *some picture*
@@ -142,7 +210,7 @@ void getPixelsP6(image& picture, ifstream& fin)
  * @endverbatim
  ***********************************************************************/
  //Gets pixels from ascii files DON'T TOUCH IT FINALLY WORKS
-void getPixelsP3(image& picture, ifstream& fin)
+void getPixelsP3(image& picture, istream& fin)
 {
 	int temp;
 	for (int i = 0; i < picture.rows; i++)
@@ -166,9 +234,12 @@ void getPixelsP3(image& picture, ifstream& fin)
  *
  *
  * @param[in] type - file type to output as, acceptable inputs as "--binary" or "--ascii", MUST match fout open type.
- * @param[in, out] fout - ofstream containing valid opened file to write to
+ * @param[in, out] fout - stream containing valid opened file to write to
  * @paramp[in, out] picture - Struct containing picture data
  *
+ * Pixel data is collected into chunks of about OUTPUT_CHUNK bytes and each
+ * chunk is written with one call, rather than one small write per pixel.
+ *
  * @par Example:
  *  @verbatim
  * image picture = *some picture*;
@@ -177,7 +248,7 @@ void getPixelsP3(image& picture, ifstream& fin)
  * writeFile(type, fout, picture); //writes all data through fout to the file
  * @endverbatim
  ***********************************************************************/
-void writeFile(string type, ofstream& fout, image& picture)
+void writeFile(string type, ostream& fout, image& picture)
 {
 	if (type == "P6")
 	{
@@ -185,18 +256,21 @@ void writeFile(string type, ofstream& fout, image& picture)
 		fout << picture.comment;
 		fout << picture.cols << " " << picture.rows << endl;
 		fout << "255" << endl;
-		int i = 0;
-		int j = 0;
+		string chunk;
+		chunk.reserve(OUTPUT_CHUNK + picture.cols * 3);
 		for (int i = 0; i < picture.rows; i++)
 		{
+			//Interleave rows into one chunk, then write it in a single call
 			for (int j = 0; j < picture.cols; j++)
 			{
-				fout.write((char*)&picture.redgray[i][j], sizeof(pixel));
-
-				fout.write((char*)&picture.green[i][j], sizeof(pixel));
-
-				fout.write((char*)&picture.blue[i][j], sizeof(pixel));
-
+				chunk += (char)picture.redgray[i][j];
+				chunk += (char)picture.green[i][j];
+				chunk += (char)picture.blue[i][j];
+			}
+			if (chunk.size() >= OUTPUT_CHUNK || i == picture.rows - 1)
+			{
+				fout.write(chunk.data(), chunk.size());
+				chunk.clear();
 			}
 		}
 	}
@@ -207,13 +281,21 @@ void writeFile(string type, ofstream& fout, image& picture)
 		fout << picture.comment;
 		fout << picture.cols << " " << picture.rows << endl;
 		fout << "255" << endl;
+		string chunk;
+		chunk.reserve(OUTPUT_CHUNK + picture.cols * 12);
 		for (int i = 0; i < picture.rows; i++)
 		{
+			//Format rows into one chunk, then write it in a single call
 			for (int j = 0; j < picture.cols; j++)
 			{
-				fout << (int)picture.redgray[i][j] << ' '
-					<< (int)picture.green[i][j] << ' '
-					<< (int)picture.blue[i][j] << endl;
+				chunk += to_string((int)picture.redgray[i][j]) + ' ';
+				chunk += to_string((int)picture.green[i][j]) + ' ';
+				chunk += to_string((int)picture.blue[i][j]) + '\n';
+			}
+			if (chunk.size() >= OUTPUT_CHUNK || i == picture.rows - 1)
+			{
+				fout.write(chunk.data(), chunk.size());
+				chunk.clear();
 			}
 		}
 	}
@@ -226,7 +308,7 @@ void writeFile(string type, ofstream& fout, image& picture)
  *
  *
  * @param[in] type - file type to output as, acceptable inputs as "--binary" or "--ascii", MUST match fout open type.
- * @param[in, out] fout - ofstream containing valid opened file to write to
+ * @param[in, out] fout - stream containing valid opened file to write to
  * @paramp[in, out] picture - Struct containing picture data
  *
  * @par Example:
@@ -237,7 +319,7 @@ void writeFile(string type, ofstream& fout, image& picture)
  * writeFileGray(type, fout, picture); //writes all data through fout to the file
  * @endverbatim
  ***********************************************************************/
-void writeFileGray(string type, ofstream& fout, image& picture)
+void writeFileGray(string type, ostream& fout, image& picture)
 {
 	if (type == "--binary")
 	{
@@ -271,4 +353,252 @@ void writeFileGray(string type, ofstream& fout, image& picture)
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description: This function creates a new, empty temporary file that
+ * an image is written to before it replaces file. The file is created
+ * exclusively under a unique name, so an existing file is never reused and
+ * two jobs writing the same output never share a temporary file. It is in
+ * the same directory as file so the final rename never crosses file systems.
+ *
+ *
+ * @param[in] file - Final output file.
+ * @param[out] tempFile - Name of the temporary file.
+ *
+ * @returns true - The temporary file was created
+ * @returns false - It could not be created
+ *
+ * @par Example:
+ *  @verbatim
+ * string temp;
+ * createTempFile("image.ppm", temp); //temp is "image.ppm.a1B2c3"
+ * @endverbatim
+ ***********************************************************************/
+bool createTempFile(string file, string& tempFile)
+{
+#ifdef _WIN32
+	char name[MAX_PATH];
+	size_t slash = file.find_last_of("/\\");
+	string dir = slash == string::npos ? "." : file.substr(0, slash + 1);
+
+	if (GetTempFileNameA(dir.c_str(), "ppm", 0, name) == 0)
+	{
+		cout << "Unable to create temporary file for: " << file << endl;
+		return false;
+	}
+	tempFile = name;
+	return true;
+#else
+	string pattern = file + ".XXXXXX";
+	vector<char> name(pattern.begin(), pattern.end());
+	name.push_back('\0');
+
+	int fd = mkstemp(name.data());
+	if (fd < 0)
+	{
+		cout << "Unable to create temporary file for: " << file << endl;
+		return false;
+	}
+	close(fd);
+	tempFile = name.data();
+	return true;
+#endif
+}
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description: This function finishes writing a temporary output file
+ * and moves it over the final file. The stream is closed and checked for
+ * write errors, the temporary file takes the permissions (and, where
+ * allowed, the owner) of the file it replaces, the data is flushed to disk
+ * according to policy, and the temporary file is renamed over file in one
+ * step. If anything fails before the rename the temporary file is removed
+ * and file is left untouched.
+ *
+ * Sync policies:
+ *  none - rename only, leave flushing to the operating system
+ *  file - flush the temporary file to disk before the rename
+ *  full - also flush the directory after the rename, so the rename itself
+ *         survives a power loss
+ *
+ *
+ * @param[in, out] fout - ofstream writing to tempFile, closed on return
+ * @param[in] tempFile - Temporary file the image was written to.
+ * @param[in] file - Final output file.
+ * @param[in] policy - Sync policy, one of none, file or full.
+ *
+ * @returns true - The image replaced file and was synced as requested
+ * @returns false - Something failed, the reason has been printed
+ *
+ * @par Example:
+ *  @verbatim
+ * ofstream fout;
+ * string temp;
+ * createTempFile("image.ppm", temp);
+ * openOutput(fout, temp, "P6");
+ * writeFile("P6", fout, picture);
+ * commitOutput(fout, temp, "image.ppm", "file");
+ * @endverbatim
+ ***********************************************************************/
+bool commitOutput(ofstream& fout, string tempFile, string file, string policy)
+{
+	bool failed = false;
+
+	fout.close();
+	if (fout.fail())
+	{
+		cout << "Unable to write file: " << tempFile << endl;
+		remove(tempFile.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	if (policy == "file" || policy == "full")
+	{
+		int fd = _open(tempFile.c_str(), _O_WRONLY | _O_BINARY);
+		failed = fd < 0 || _commit(fd) != 0;
+		if (fd >= 0)
+			_close(fd);
+		if (failed)
+		{
+			cout << "Unable to sync file: " << tempFile << endl;
+			remove(tempFile.c_str());
+			return false;
+		}
+	}
+
+	//ReplaceFile keeps the attributes, owner and ACL of the file it replaces
+	if (GetFileAttributesA(file.c_str()) != INVALID_FILE_ATTRIBUTES)
+		failed = !ReplaceFileA(file.c_str(), tempFile.c_str(), NULL,
+			REPLACEFILE_IGNORE_MERGE_ERRORS, NULL, NULL);
+	else
+		failed = !MoveFileExA(tempFile.c_str(), file.c_str(),
+			policy == "full" ? MOVEFILE_WRITE_THROUGH : 0);
+	if (failed)
+	{
+		cout << "Unable to replace file: " << file << endl;
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	if (policy == "full")
+	{
+		HANDLE h = CreateFileA(file.c_str(), GENERIC_WRITE, FILE_SHARE_READ,
+			NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		failed = h == INVALID_HANDLE_VALUE || !FlushFileBuffers(h);
+		if (h != INVALID_HANDLE_VALUE)
+			CloseHandle(h);
+		if (failed)
+		{
+			cout << "Unable to sync file: " << file << endl;
+			return false;
+		}
+	}
+#else
+	struct stat original;
+	bool replacing = stat(file.c_str(), &original) == 0;
+	int fd = open(tempFile.c_str(), O_WRONLY);
+
+	if (fd < 0)
+	{
+		cout << "Unable to open file: " << tempFile << endl;
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	//mkstemp creates the file as 0600, so always set the final mode
+	if (replacing)
+	{
+		//Changing the owner needs root, so keep ours if it is not allowed
+		if ((original.st_uid != geteuid() || original.st_gid != getegid()) &&
+			fchown(fd, original.st_uid, original.st_gid) != 0)
+			cout << "Note: unable to keep the owner of " << file << endl;
+		//Set the mode after the owner, a chown may clear setuid and setgid
+		failed = fchmod(fd, original.st_mode & 07777) != 0;
+	}
+	else
+	{
+		mode_t mask = umask(0);
+		umask(mask);
+		failed = fchmod(fd, 0666 & ~mask) != 0;
+	}
+	if (failed)
+	{
+		cout << "Unable to set permissions on file: " << tempFile << endl;
+		close(fd);
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	if (policy == "file" || policy == "full")
+	{
+		if (fsync(fd) != 0)
+		{
+			cout << "Unable to sync file: " << tempFile << endl;
+			close(fd);
+			remove(tempFile.c_str());
+			return false;
+		}
+	}
+	close(fd);
+
+	if (rename(tempFile.c_str(), file.c_str()) != 0)
+	{
+		cout << "Unable to replace file: " << file << endl;
+		remove(tempFile.c_str());
+		return false;
+	}
+
+	if (policy == "full")
+	{
+		size_t slash = file.find_last_of('/');
+		string dir = slash == string::npos ? "." : file.substr(0, slash + 1);
+		fd = open(dir.c_str(), O_RDONLY);
+		failed = fd < 0 || fsync(fd) != 0;
+		if (fd >= 0)
+			close(fd);
+		if (failed)
+		{
+			//The rename has already happened, so there is nothing to remove
+			cout << "Unable to sync directory: " << dir << endl;
+			return false;
+		}
+	}
+#endif
+	return true;
+}
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description: This function follows symbolic links in the output
+ * path, so the temporary file is created next to the real file and the
+ * rename replaces the link's target rather than the link itself. A file
+ * that does not exist yet is returned unchanged. Links are not followed
+ * on Windows.
+ *
+ *
+ * @param[in] file - Output file as given on the command line.
+ *
+ * @returns The path of the file that will be replaced.
+ *
+ * @par Example:
+ *  @verbatim
+ * //link.ppm -> images/real.ppm
+ * string out = resolveOutput("link.ppm"); //out is "/full/path/images/real.ppm"
+ * @endverbatim
+ ***********************************************************************/
+string resolveOutput(string file)
+{
+#ifdef _WIN32
+	return file;
+#else
+	char* path = realpath(file.c_str(), nullptr);
+	if (path == nullptr)
+		return file;
+	string resolved = path;
+	free(path);
+	return resolved;
+#endif
+}
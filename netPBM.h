@@ -4,11 +4,15 @@
  * @brief  Prototypes
  ***********************************************************************/
 #pragma once
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
 #include <vector>
 
 using namespace std;
@@ -51,23 +55,55 @@ struct color
     int blueValue; /** Blue pixel value*/
 };
 
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Tile summary of an image. The image is split into tileSize x tileSize
+ * blocks, and each block is flagged as either uniform (every pixel is the
+ * same color, stored in the tile color arrays) or mixed.
+ *
+ *
+ ***********************************************************************/
+struct tileIndex
+{
+    int tileSize; /** Width and height of a tile, in pixels*/
+    int tileRows; /** Number of tile rows covering the image*/
+    int tileCols; /** Number of tile columns covering the image*/
+    bool** uniform; /** True if every pixel in the tile is the same color*/
+    pixel** redgray; /** Red value of each uniform tile*/
+    pixel** green; /** Green value of each uniform tile*/
+    pixel** blue; /** Blue value of each uniform tile*/
+};
+
+const int TILE_SIZE = 64; /** Default tile dimension used by the tiled fill*/
+
 /************************************************************************
  *                         Function Prototypes
  ***********************************************************************/
 void openInput(ifstream& fin, string file);
-void openOutput(ofstream& fout, string file, string type);
+bool openOutput(ofstream& fout, string file, string type);
+string resolveOutput(string file);
+bool createTempFile(string file, string& tempFile);
+bool commitOutput(ofstream& fout, string tempFile, string file, string policy);
 
 void createArray(pixel**& ptr, int cols, int rows);
 void createBoolArray(bool**& ptr, int cols, int row);
 
-void getPixelsP6(image& picture, ifstream& fin);
-void getPixelsP3(image& picture, ifstream& fin);
+bool readHeader(image& picture, istream& fin);
+void getPixelsP6(image& picture, istream& fin);
+void getPixelsP3(image& picture, istream& fin);
 
-void writeFile(string type, ofstream& fout, image& picture);
-void writeFileGray(string type, ofstream& fout, image& picture);
+void writeFile(string type, ostream& fout, image& picture);
+void writeFileGray(string type, ostream& fout, image& picture);
 
 void cleanUp(bool** arr1, image picture);
+void cleanUpImage(image picture);
+void cleanUpTiles(tileIndex& tiles);
+
+void buildTileIndex(image& picture, tileIndex& tiles, int tileSize);
 
 void bucketFill(image& picture, color newColor, color ogColor, int row, int col, bool**& adjPixels);
 bool isEqual(color color1, color colorc2);
+void bucketFillTiled(image& picture, color newColor, color ogColor, int row, int col, bool**& adjPixels, tileIndex& tiles);
 #endif
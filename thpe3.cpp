@@ -42,7 +42,8 @@
  * @par Usage:
  *  @verbatim
  *  minimal run:
- *  c:\> thpe3.exe imageFile row col redValue greenValue blueValue
+ *  c:\> thpe3.exe imageFile row col redValue greenValue blueValue [--tiles]
+ *                  [--out outFile] [--fsync none|file|full]
  *
  * where imageFile is a valid .ppm image;
  *       row is the row of a pixel in a spot to bucket fill
@@ -50,10 +51,30 @@
  *       redValue is the color of the red channel for the replacement color
  *       greenValue is the color of the green channel for the replacement color
  *       blueValue is the color of the blue channel for the replacement color
+ *       --tiles builds a 64x64 tile summary after reading the image and fills
+ *               flat tiles a row at a time instead of pixel by pixel
+ *       --out writes the result to outFile instead of overwriting imageFile
+ *       --fsync sets how hard the output is flushed to disk (default file):
+ *               none - no flush, file - flush the image before it replaces
+ *               the output file, full - also flush the directory entry
+ *
+ * The image is always written to a new temporary file next to the output
+ * file and then renamed over it, so a crash while writing never destroys the
+ * source image. The output keeps the permissions of the file it replaces.
+ * If the output is a symbolic link, the file it points to is replaced and
+ * the link is kept (not on Windows, where the link itself is replaced).
  *
  *
  *  @endverbatim
  *
+ * @section test_section Testing
+ *
+ * @details The thpe3Tests project holds bucketFill and the original writeFile as the reference, and
+ * checks on random small images that bucketFillTiled, writeFile and the output stage produce
+ * byte-identical results and that readHeader/getPixelsP3/P6 read them back. Run
+ * thpe3Tests.exe [seed] [iterations]; it returns 1 and prints the seed of any failure.
+ * fuzzReader.cpp is a libFuzzer entry point for the header and pixel readers.
+ *
  * @section todo_bugs_modification_section Todo, Bugs, and Modifications
  *
  * @bug The program wouldn't handle the same file twice, failing to process the magic number
@@ -69,7 +90,7 @@
  *
  ***********************************************************************/
 
-#include "netpbm.h"
+#include "netPBM.h"
 
  /** *********************************************************************
   * @author Tristan Opbroek
@@ -98,31 +119,57 @@ int main(int argc, char** argv)
     color ogColor;
     color newColor;
     bool** adjPixels;
-
-    if (argc != 7)
+    tileIndex tiles;
+    bool useTiles = false;
+    string outFile;
+    string tempFile;
+    string syncPolicy = "file";
+    string usage = "thpe03.exe imageFile row col redValue greenValue blueValue"
+        " [--tiles] [--out outFile] [--fsync none|file|full]";
+
+    if (argc < 7)
     {
         cout << "Invalid Number of Arguments!" << endl;
         cout << "Usage:" << endl;
-        cout << "thpe03.exe imageFile row col redValue greenValue blueValue";
+        cout << usage;
         return 0;
     }
+    outFile = argv[1];
+    for (int i = 7; i < argc; i++) //Optional arguments
+    {
+        tempString = argv[i];
+        if (tempString == "--tiles")
+            useTiles = true;
+        else if (tempString == "--out" && i + 1 < argc)
+            outFile = argv[++i];
+        else if (tempString == "--fsync" && i + 1 < argc)
+        {
+            syncPolicy = argv[++i];
+            if (syncPolicy != "none" && syncPolicy != "file" && syncPolicy != "full")
+            {
+                cout << "Unrecognized fsync policy " << syncPolicy << endl;
+                cout << "Usage:" << endl;
+                cout << usage;
+                return 0;
+            }
+        }
+        else
+        {
+            cout << "Unrecognized option " << tempString << endl;
+            cout << "Usage:" << endl;
+            cout << usage;
+            return 0;
+        }
+    }
 
     openInput(fin, argv[1]); //Open File
 
     //----------------Image operations--------------
-    fin >> picture.magicNumber;
-    fin.ignore(1000, '\n');
-    //getline(fin, picture.magicNumber, '\n'); //Extract magicnumber
-    while (fin.peek() == 35) //Extract Comments
+    if (!readHeader(picture, fin))
     {
-        getline(fin, tempString);
-        picture.comment += tempString + '\n';
+        cout << "Invalid image header in " << argv[1] << endl;
+        return 0;
     }
-    getline(fin, tempString, ' '); //Get cols, put in struct
-    picture.cols = stoi(tempString);
-    getline(fin, tempString, '\n'); //Get rows, put in struct
-    picture.rows = stoi(tempString);
-    getline(fin, tempString, '\n'); //Skip Newline
 
     createArray(picture.redgray, picture.cols, picture.rows); //allocate memory.
     createArray(picture.green, picture.cols, picture.rows);
@@ -160,107 +207,29 @@ int main(int argc, char** argv)
         }
     }
     //-------------------------------------
-    bucketFill(picture, newColor, ogColor, stoi(argv[2]), stoi(argv[3]), adjPixels);
+    if (useTiles)
+    {
+        buildTileIndex(picture, tiles, TILE_SIZE);
+        bucketFillTiled(picture, newColor, ogColor, stoi(argv[2]), stoi(argv[3]), adjPixels, tiles);
+        cleanUpTiles(tiles);
+    }
+    else
+        bucketFill(picture, newColor, ogColor, stoi(argv[2]), stoi(argv[3]), adjPixels);
     fin.close();
-    openOutput(fout, argv[1], picture.magicNumber);
+    outFile = resolveOutput(outFile);
+    if (!createTempFile(outFile, tempFile))
+    {
+        cleanUp(adjPixels, picture);
+        return 0;
+    }
+    if (!openOutput(fout, tempFile, picture.magicNumber))
+    {
+        remove(tempFile.c_str());
+        cleanUp(adjPixels, picture);
+        return 0;
+    }
     writeFile(picture.magicNumber, fout, picture);
-    fout.close();
+    commitOutput(fout, tempFile, outFile, syncPolicy); //Reports its own errors
     cleanUp(adjPixels, picture);
     return 0;
 }
-
-
-//Functions go here
- /** *********************************************************************
-  * @author Tristan Opbroek
-  *
-  * @par Description:
-  * Compares two color structures and determines if they are equal.
-  *
-  *
-  * @param[in] color1 - The first color in the comparison
-  * @param[in] color2 - The second color in the comparison
-  *
-  * @returns true - Colors are equal
-  * @returns false - Colors are not equal
-  *
- * @par Example:
-   @verbatim
-    color c1;
-    color c2;
-    c1.redValue = 1
-    c1.greenValue = 1
-    c1.blueValue = 1
-    
-    c2.redValue = 1
-    c2.greenValue = 1
-    c2.blueValue = 1
-    
-    cout << isEqual(c1, c2) << endl; //Outputs true.
-   @endverbatim
-  ***********************************************************************/
-bool isEqual(color color1, color color2)
-{
-    if (color1.redValue == color2.redValue &&
-        color1.greenValue == color2.greenValue &&
-        color1.blueValue == color2.blueValue)
-        return true;
-    else
-        return false;
-}
-/** *********************************************************************
- * @author Tristan Opbroek
- *
- * @par Description:
- * Recursively steps through an image and replaces the color of all pixels of the same color that are touching, within bounds of the image.
- * 
- *
- *
- * @param[in] picture - The image struct being passed in
- * @param[in] newColor - The color to replace pixels with.
- * @param[in] ogColor - The original pixel color (target pixel)
- * @param[in] row - Target pixel row
- * @param[in] col - Target pixel col
- * @param[in] adjPixels - 2D array of used pixels.
- * 
- * 
- *
-* @par Example:
-  @verbatim
-  image picture; //Contains good image data
-  color newColor; //Contains 255, 0, 0; or the color red
-  color ogCOlor; //Contains color of pixel at row, col, in image
-  int row = 0; //Start bucket fill in top left corner
-  int col = 0;
-  bool** adjPixels; //2D array of size picture.row * picture.col, containing all false.
-
-   cout << isEqual(c1, c2) << endl; //Outputs true.
-  @endverbatim
- ***********************************************************************/
-void bucketFill(image& picture, color newColor, color ogColor, int row, int col, bool**& adjPixels)
-{
-
-    color currColor;
-
-    currColor.redValue = picture.redgray[row][col];
-    currColor.greenValue = picture.green[row][col];
-    currColor.blueValue = picture.blue[row][col];
-    if (adjPixels[row][col] == false &&
-        isEqual(currColor, ogColor))
-    {
-        adjPixels[row][col] = true;
-        picture.redgray[row][col] = newColor.redValue;
-        picture.green[row][col] = newColor.greenValue;
-        picture.blue[row][col] = newColor.blueValue;
-
-        if (row != 0)
-            bucketFill(picture, newColor, ogColor, row - 1, col, adjPixels);
-        if (row != picture.rows - 1)
-            bucketFill(picture, newColor, ogColor, row + 1, col, adjPixels);
-        if (col != 0)
-            bucketFill(picture, newColor, ogColor, row, col - 1, adjPixels);
-        if (col != picture.cols - 1)
-            bucketFill(picture, newColor, ogColor, row, col + 1, adjPixels);
-    }
-    adjPixels[row][col] = true;
-}
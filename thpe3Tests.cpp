@@ -0,0 +1,455 @@
+/** *********************************************************************
+ * @file
+ *
+ * @brief Differential tests. Random small images are run through the
+ * reference code (the recursive bucketFill and the original per pixel
+ * writer) and through every faster path, and the results must match byte
+ * for byte. The readers are checked by round trip and by feeding damaged
+ * images to the fuzz entry point.
+ *
+ * @par Usage:
+ *  @verbatim
+ *  c:\> thpe3Tests.exe [seed] [iterations]
+ *  @endverbatim
+ * Prints each failure with the seed that reproduces it, and returns 1 if
+ * anything failed.
+ ***********************************************************************/
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include "netPBM.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+const int MAX_DIM = 48; /** Largest test image side, keeps the recursion shallow*/
+
+int checks = 0; /** Number of comparisons made*/
+int failures = 0; /** Number of comparisons that did not match*/
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Records the result of one comparison and reports it if it failed.
+ *
+ * @param[in] passed - Result of the comparison.
+ * @param[in] what - Name of the comparison.
+ * @param[in] seed - Seed that reproduces it.
+ ***********************************************************************/
+void check(bool passed, string what, unsigned seed)
+{
+	checks++;
+	if (!passed)
+	{
+		failures++;
+		cout << "FAILED " << what << " (seed " << seed << ")" << endl;
+	}
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * The original writeFile, one write call per channel and a flush per
+ * pixel in P3. The optimized writeFile must produce the same bytes.
+ *
+ * @param[in] type - P3 or P6.
+ * @param[in, out] fout - stream to write to.
+ * @param[in] picture - Struct containing picture data.
+ ***********************************************************************/
+void refWriteFile(string type, ostream& fout, image& picture)
+{
+	if (type == "P6")
+	{
+		fout << "P6" << endl;
+		fout << picture.comment;
+		fout << picture.cols << " " << picture.rows << endl;
+		fout << "255" << endl;
+		for (int i = 0; i < picture.rows; i++)
+		{
+			for (int j = 0; j < picture.cols; j++)
+			{
+				fout.write((char*)&picture.redgray[i][j], sizeof(pixel));
+				fout.write((char*)&picture.green[i][j], sizeof(pixel));
+				fout.write((char*)&picture.blue[i][j], sizeof(pixel));
+			}
+		}
+	}
+	if (type == "P3")
+	{
+		fout << "P3" << endl;
+		fout << picture.comment;
+		fout << picture.cols << " " << picture.rows << endl;
+		fout << "255" << endl;
+		for (int i = 0; i < picture.rows; i++)
+		{
+			for (int j = 0; j < picture.cols; j++)
+			{
+				fout << (int)picture.redgray[i][j] << ' '
+					<< (int)picture.green[i][j] << ' '
+					<< (int)picture.blue[i][j] << endl;
+			}
+		}
+	}
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Fills picture with a random image made of solid and noisy blocks drawn
+ * from a small palette, so fills find both large flat regions and ragged
+ * edges. Some palette colors differ from each other in one channel only.
+ *
+ * @param[out] picture - Image to create, arrays are allocated here.
+ * @param[in, out] rng - Random number source.
+ ***********************************************************************/
+void randomImage(image& picture, mt19937& rng)
+{
+	const int blockSizes[] = { 1, 2, 4, 8, 16, MAX_DIM };
+	int blockSize = blockSizes[rng() % 6];
+	color palette[4];
+	int colors = 2 + rng() % 3;
+
+	picture.magicNumber = rng() % 2 ? "P6" : "P3";
+	picture.comment = rng() % 2 ? "# test image\n" : "";
+	picture.rows = 1 + rng() % MAX_DIM;
+	picture.cols = 1 + rng() % MAX_DIM;
+	createArray(picture.redgray, picture.cols, picture.rows);
+	createArray(picture.green, picture.cols, picture.rows);
+	createArray(picture.blue, picture.cols, picture.rows);
+
+	for (int k = 0; k < colors; k++)
+	{
+		palette[k].redValue = rng() % 256;
+		palette[k].greenValue = rng() % 256;
+		palette[k].blueValue = rng() % 256;
+	}
+	palette[1] = palette[0]; //One channel away from palette[0]
+	palette[1].blueValue = (palette[0].blueValue + 1) % 256;
+
+	for (int bi = 0; bi < picture.rows; bi += blockSize)
+	{
+		for (int bj = 0; bj < picture.cols; bj += blockSize)
+		{
+			bool solid = rng() % 5 < 3;
+			color c = palette[rng() % colors];
+			for (int i = bi; i < min(bi + blockSize, picture.rows); i++)
+			{
+				for (int j = bj; j < min(bj + blockSize, picture.cols); j++)
+				{
+					if (!solid)
+						c = palette[rng() % colors];
+					picture.redgray[i][j] = c.redValue;
+					picture.green[i][j] = c.greenValue;
+					picture.blue[i][j] = c.blueValue;
+				}
+			}
+		}
+	}
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Makes a deep copy of an image.
+ *
+ * @param[in] src - Image to copy.
+ * @param[out] dst - New image, arrays are allocated here.
+ ***********************************************************************/
+void copyImage(image& src, image& dst)
+{
+	dst.magicNumber = src.magicNumber;
+	dst.comment = src.comment;
+	dst.rows = src.rows;
+	dst.cols = src.cols;
+	createArray(dst.redgray, dst.cols, dst.rows);
+	createArray(dst.green, dst.cols, dst.rows);
+	createArray(dst.blue, dst.cols, dst.rows);
+	for (int i = 0; i < src.rows; i++)
+	{
+		memcpy(dst.redgray[i], src.redgray[i], src.cols);
+		memcpy(dst.green[i], src.green[i], src.cols);
+		memcpy(dst.blue[i], src.blue[i], src.cols);
+	}
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Compares the dimensions and pixel arrays of two images.
+ *
+ * @param[in] a - First image.
+ * @param[in] b - Second image.
+ *
+ * @returns true - Same size and every pixel matches
+ * @returns false - Anything differs
+ ***********************************************************************/
+bool samePixels(image& a, image& b)
+{
+	if (a.rows != b.rows || a.cols != b.cols)
+		return false;
+	for (int i = 0; i < a.rows; i++)
+	{
+		if (memcmp(a.redgray[i], b.redgray[i], a.cols) != 0 ||
+			memcmp(a.green[i], b.green[i], a.cols) != 0 ||
+			memcmp(a.blue[i], b.blue[i], a.cols) != 0)
+			return false;
+	}
+	return true;
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Encodes an image to a string with either writeFile or refWriteFile.
+ *
+ * @param[in] picture - Image to encode.
+ * @param[in] type - P3 or P6.
+ * @param[in] reference - Use refWriteFile instead of writeFile.
+ *
+ * @returns The bytes of the image file.
+ ***********************************************************************/
+string encode(image& picture, string type, bool reference)
+{
+	ostringstream fout(ios::out | ios::binary);
+	if (reference)
+		refWriteFile(type, fout, picture);
+	else
+		writeFile(type, fout, picture);
+	return fout.str();
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Allocates a visited array for a fill, with every entry false.
+ *
+ * @param[out] adjPixels - Array to allocate.
+ * @param[in] picture - Image the array is for.
+ ***********************************************************************/
+void clearedBoolArray(bool**& adjPixels, image& picture)
+{
+	createBoolArray(adjPixels, picture.cols, picture.rows);
+	for (int i = 0; i < picture.rows; i++)
+		fill(adjPixels[i], adjPixels[i] + picture.cols, false);
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Fills a copy of picture with bucketFill and another copy with
+ * bucketFillTiled from the same pixel and color, using a random tile size,
+ * and checks the pixels and both encodings match.
+ *
+ * @param[in] picture - Source image, not modified.
+ * @param[in, out] rng - Random number source.
+ * @param[in] seed - Seed that reproduces this case.
+ ***********************************************************************/
+void testFill(image& picture, mt19937& rng, unsigned seed)
+{
+	const int tileSizes[] = { 1, 2, 3, 5, 8, 16, TILE_SIZE };
+	image reference;
+	image tiled;
+	tileIndex tiles;
+	bool** adjReference;
+	bool** adjTiled;
+	int row = rng() % picture.rows;
+	int col = rng() % picture.cols;
+	color ogColor;
+	color newColor;
+
+	ogColor.redValue = picture.redgray[row][col];
+	ogColor.greenValue = picture.green[row][col];
+	ogColor.blueValue = picture.blue[row][col];
+	newColor.redValue = rng() % 256;
+	newColor.greenValue = rng() % 256;
+	newColor.blueValue = rng() % 256;
+	if (rng() % 4 == 0) //Filling with the same color must change nothing
+		newColor = ogColor;
+
+	copyImage(picture, reference);
+	copyImage(picture, tiled);
+	clearedBoolArray(adjReference, picture);
+	clearedBoolArray(adjTiled, picture);
+
+	bucketFill(reference, newColor, ogColor, row, col, adjReference);
+	buildTileIndex(tiled, tiles, tileSizes[rng() % 7]);
+	bucketFillTiled(tiled, newColor, ogColor, row, col, adjTiled, tiles);
+
+	check(samePixels(reference, tiled), "bucketFillTiled pixels", seed);
+	check(encode(reference, "P6", true) == encode(tiled, "P6", false),
+		"bucketFillTiled P6 output", seed);
+	check(encode(reference, "P3", true) == encode(tiled, "P3", false),
+		"bucketFillTiled P3 output", seed);
+
+	cleanUpTiles(tiles);
+	cleanUp(adjReference, reference);
+	cleanUp(adjTiled, tiled);
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Checks writeFile against refWriteFile in both formats, then reads the
+ * output back with readHeader and getPixelsP3/P6 and checks it matches.
+ *
+ * @param[in] picture - Image to encode.
+ * @param[in] seed - Seed that reproduces this case.
+ ***********************************************************************/
+void testCodec(image& picture, unsigned seed)
+{
+	string types[] = { "P3", "P6" };
+
+	for (string type : types)
+	{
+		string file = encode(picture, type, false);
+		istringstream fin(file, ios::in | ios::binary);
+		image decoded;
+
+		check(file == encode(picture, type, true), type + " writeFile output", seed);
+
+		//Without a good header the sizes are unset, so skip the pixels
+		if (!readHeader(decoded, fin) || decoded.magicNumber != type)
+		{
+			check(false, type + " readHeader", seed);
+			continue;
+		}
+		check(decoded.comment == picture.comment, type + " readHeader comment", seed);
+		createArray(decoded.redgray, decoded.cols, decoded.rows);
+		createArray(decoded.green, decoded.cols, decoded.rows);
+		createArray(decoded.blue, decoded.cols, decoded.rows);
+		if (type == "P3")
+			getPixelsP3(decoded, fin);
+		else
+			getPixelsP6(decoded, fin);
+		check(samePixels(picture, decoded), type + " round trip", seed);
+		cleanUpImage(decoded);
+	}
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Writes picture through the real output stage (createTempFile,
+ * openOutput, writeFile, commitOutput) and checks each step succeeds and
+ * the file on disk matches refWriteFile. The file name includes the seed
+ * so runs in parallel do not collide.
+ *
+ * @param[in] picture - Image to write.
+ * @param[in] seed - Seed that reproduces this case.
+ ***********************************************************************/
+void testCommit(image& picture, unsigned seed)
+{
+	string outFile = "thpe3Tests" + to_string(seed) + ".ppm";
+	string tempFile;
+	ofstream fout;
+	ifstream fin;
+	ostringstream contents(ios::out | ios::binary);
+
+	if (!createTempFile(outFile, tempFile))
+	{
+		check(false, "createTempFile", seed);
+		return;
+	}
+	if (!openOutput(fout, tempFile, picture.magicNumber))
+	{
+		check(false, "openOutput", seed);
+		remove(tempFile.c_str());
+		return;
+	}
+	writeFile(picture.magicNumber, fout, picture);
+	if (!commitOutput(fout, tempFile, outFile, "none"))
+	{
+		check(false, "commitOutput", seed);
+		return;
+	}
+
+	fin.open(outFile, ios::in | ios::binary);
+	check(fin.is_open(), "commitOutput file exists", seed);
+	contents << fin.rdbuf();
+	fin.close();
+	remove(outFile.c_str());
+
+	check(contents.str() == encode(picture, picture.magicNumber, true),
+		"commitOutput file contents", seed);
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Feeds truncated, bit flipped and random versions of an encoded image to
+ * the fuzz entry point. Passing means nothing crashed; run under a
+ * sanitizer to catch bad reads.
+ *
+ * @param[in] picture - Image to damage.
+ * @param[in, out] rng - Random number source.
+ ***********************************************************************/
+void testFuzz(image& picture, mt19937& rng)
+{
+	string file = encode(picture, picture.magicNumber, false);
+	string damaged;
+
+	LLVMFuzzerTestOneInput((const uint8_t*)file.data(), file.size());
+
+	damaged = file.substr(0, rng() % (file.size() + 1));
+	LLVMFuzzerTestOneInput((const uint8_t*)damaged.data(), damaged.size());
+
+	damaged = file;
+	for (int k = 1 + rng() % 4; k > 0; k--)
+		damaged[rng() % damaged.size()] = (char)rng();
+	LLVMFuzzerTestOneInput((const uint8_t*)damaged.data(), damaged.size());
+
+	damaged = picture.magicNumber + "\n";
+	for (int k = rng() % 64; k > 0; k--)
+		damaged += (char)rng();
+	LLVMFuzzerTestOneInput((const uint8_t*)damaged.data(), damaged.size());
+}
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Runs every test on a fresh random image for each iteration.
+ *
+ * @param[in] argc - the number of arguments from the command prompt.
+ * @param[in] argv - optional seed and iteration count.
+ *
+ * @returns 0 -- every check passed
+ * @returns 1 -- at least one check failed
+ ***********************************************************************/
+int main(int argc, char** argv)
+{
+	unsigned seed = argc > 1 ? stoul(argv[1]) : 1;
+	int iterations = argc > 2 ? stoi(argv[2]) : 500;
+
+	for (int i = 0; i < iterations; i++)
+	{
+		mt19937 rng(seed + i);
+		image picture;
+
+		randomImage(picture, rng);
+		testFill(picture, rng, seed + i);
+		testCodec(picture, seed + i);
+		if (i % 50 == 0)
+			testCommit(picture, seed + i);
+		testFuzz(picture, rng);
+		cleanUpImage(picture);
+	}
+
+	if (failures != 0)
+	{
+		cout << failures << " of " << checks << " checks failed" << endl;
+		return 1;
+	}
+	cout << "All " << checks << " checks passed" << endl;
+	return 0;
+}
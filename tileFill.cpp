@@ -0,0 +1,190 @@
+/** *********************************************************************
+ * @file
+ *
+ * @brief   Tile summary index and the tiled bucket fill that uses it.
+ ***********************************************************************/
+#include "netPBM.h"
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description: This function splits the image into tileSize x tileSize
+ * blocks and records, for each block, whether every pixel in it has the same
+ * color. Tiles along the right and bottom edges may be smaller than tileSize.
+ *
+ *
+ * @param[in] picture - struct containing picture data, already decoded
+ * @param[out] tiles - tile index to fill in
+ * @param[in] tileSize - width and height of a tile, in pixels
+ *
+ * @par Example:
+ *  @verbatim
+ * image picture = *some picture*
+ * tileIndex tiles;
+ * buildTileIndex(picture, tiles, TILE_SIZE); //tiles.uniform[0][0] is true if
+ *                                            //the top left 64x64 block is flat
+ * @endverbatim
+ ***********************************************************************/
+void buildTileIndex(image& picture, tileIndex& tiles, int tileSize)
+{
+	tiles.tileSize = tileSize;
+	tiles.tileRows = (picture.rows + tileSize - 1) / tileSize;
+	tiles.tileCols = (picture.cols + tileSize - 1) / tileSize;
+
+	createBoolArray(tiles.uniform, tiles.tileCols, tiles.tileRows);
+	createArray(tiles.redgray, tiles.tileCols, tiles.tileRows);
+	createArray(tiles.green, tiles.tileCols, tiles.tileRows);
+	createArray(tiles.blue, tiles.tileCols, tiles.tileRows);
+
+	for (int ti = 0; ti < tiles.tileRows; ti++)
+	{
+		int r0 = ti * tileSize;
+		int r1 = min(r0 + tileSize, picture.rows);
+		for (int tj = 0; tj < tiles.tileCols; tj++)
+		{
+			int c0 = tj * tileSize;
+			int c1 = min(c0 + tileSize, picture.cols);
+			pixel red = picture.redgray[r0][c0];
+			pixel green = picture.green[r0][c0];
+			pixel blue = picture.blue[r0][c0];
+			bool same = true;
+
+			//Stop scanning the tile at the first pixel that differs
+			for (int i = r0; i < r1 && same; i++)
+			{
+				for (int j = c0; j < c1; j++)
+				{
+					if (picture.redgray[i][j] != red ||
+						picture.green[i][j] != green ||
+						picture.blue[i][j] != blue)
+					{
+						same = false;
+						break;
+					}
+				}
+			}
+
+			tiles.uniform[ti][tj] = same;
+			tiles.redgray[ti][tj] = red;
+			tiles.green[ti][tj] = green;
+			tiles.blue[ti][tj] = blue;
+		}
+	}
+}
+
+
+/** *********************************************************************
+ * @author Tristan Opbroek
+ *
+ * @par Description:
+ * Bucket fills the same region as bucketFill, but without recursion and
+ * using a tile index. When the fill reaches a uniform tile whose color
+ * matches ogColor, the whole tile is connected to the fill, so it is painted
+ * a row at a time with memset and only the pixels bordering the tile are
+ * queued. Uniform tiles are matched by their stored color without reading
+ * the pixel. Mixed tiles are filled pixel by pixel.
+ *
+ *
+ * @param[in, out] picture - The image struct being passed in
+ * @param[in] newColor - The color to replace pixels with.
+ * @param[in] ogColor - The original pixel color (target pixel)
+ * @param[in] row - Target pixel row
+ * @param[in] col - Target pixel col
+ * @param[in, out] adjPixels - 2D array of used pixels, all false on entry.
+ * @param[in] tiles - Tile index built from picture before any filling.
+ *
+ * @par Example:
+   @verbatim
+   image picture; //Contains good image data
+   color newColor; //Contains 255, 0, 0; or the color red
+   color ogColor; //Contains color of pixel at row, col, in image
+   bool** adjPixels; //2D array of size picture.row * picture.col, containing all false.
+   tileIndex tiles;
+
+   buildTileIndex(picture, tiles, TILE_SIZE);
+   bucketFillTiled(picture, newColor, ogColor, 0, 0, adjPixels, tiles);
+   @endverbatim
+ ***********************************************************************/
+void bucketFillTiled(image& picture, color newColor, color ogColor, int row, int col, bool**& adjPixels, tileIndex& tiles)
+{
+	vector<pair<int, int>> pending;
+	color currColor;
+	color tileColor;
+
+	pending.push_back(make_pair(row, col));
+	while (!pending.empty())
+	{
+		int r = pending.back().first;
+		int c = pending.back().second;
+		pending.pop_back();
+
+		if (adjPixels[r][c])
+			continue;
+
+		int ti = r / tiles.tileSize;
+		int tj = c / tiles.tileSize;
+		if (tiles.uniform[ti][tj])
+		{
+			//Unvisited pixels are unpainted, so they still have the tile color
+			tileColor.redValue = tiles.redgray[ti][tj];
+			tileColor.greenValue = tiles.green[ti][tj];
+			tileColor.blueValue = tiles.blue[ti][tj];
+			if (!isEqual(tileColor, ogColor))
+			{
+				adjPixels[r][c] = true;
+				continue;
+			}
+
+			//Every pixel of this tile matches, and none have been painted yet
+			int r0 = ti * tiles.tileSize;
+			int r1 = min(r0 + tiles.tileSize, picture.rows) - 1;
+			int c0 = tj * tiles.tileSize;
+			int c1 = min(c0 + tiles.tileSize, picture.cols) - 1;
+			int width = c1 - c0 + 1;
+
+			for (int i = r0; i <= r1; i++)
+			{
+				memset(&picture.redgray[i][c0], (pixel)newColor.redValue, width);
+				memset(&picture.green[i][c0], (pixel)newColor.greenValue, width);
+				memset(&picture.blue[i][c0], (pixel)newColor.blueValue, width);
+				fill(&adjPixels[i][c0], &adjPixels[i][c0] + width, true);
+			}
+
+			//Queue the pixels just outside the tile border
+			for (int j = c0; j <= c1; j++)
+			{
+				if (r0 != 0)
+					pending.push_back(make_pair(r0 - 1, j));
+				if (r1 != picture.rows - 1)
+					pending.push_back(make_pair(r1 + 1, j));
+			}
+			for (int i = r0; i <= r1; i++)
+			{
+				if (c0 != 0)
+					pending.push_back(make_pair(i, c0 - 1));
+				if (c1 != picture.cols - 1)
+					pending.push_back(make_pair(i, c1 + 1));
+			}
+			continue;
+		}
+
+		currColor.redValue = picture.redgray[r][c];
+		currColor.greenValue = picture.green[r][c];
+		currColor.blueValue = picture.blue[r][c];
+		adjPixels[r][c] = true;
+		if (!isEqual(currColor, ogColor))
+			continue;
+		picture.redgray[r][c] = newColor.redValue;
+		picture.green[r][c] = newColor.greenValue;
+		picture.blue[r][c] = newColor.blueValue;
+
+		if (r != 0)
+			pending.push_back(make_pair(r - 1, c));
+		if (r != picture.rows - 1)
+			pending.push_back(make_pair(r + 1, c));
+		if (c != 0)
+			pending.push_back(make_pair(r, c - 1));
+		if (c != picture.cols - 1)
+			pending.push_back(make_pair(r, c + 1));
+	}
+}